@@ -20,6 +20,10 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /** Type of message that could be returned by the USB to ARINC converter */
 typedef enum
 {
@@ -61,4 +65,8 @@ arinc_box_msg_t arinc_box_decode(char raw_data);
  */
 void arinc_box_encode(uint32_t arinc_data, uint8_t encoded_char[10]);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
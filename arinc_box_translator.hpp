@@ -0,0 +1,420 @@
+/**
+* Header-only C++ version of the ARINC-429-TO-USB Converter Box translator.
+*
+* It implements the same proprietary format as arinc_box_translator.c, bit for bit, but everything
+* is constexpr and the stateful decoder is templated on the sink receiving the decoded words, so
+* that the per-byte dispatch can be fully inlined by the compiler.
+*
+* © 2023 Simtec AG. All rights reserved.
+*
+* Requires a C++20 compiler (std::span and concepts).
+*
+* Example code only. Use at own risk.
+*
+* This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+* even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* Simtec AG has no obligation to provide maintenance, support,  updates, enhancements, or modifications.
+*/
+
+#ifndef ARINC_BOX_TRANSLATOR_HPP
+#define ARINC_BOX_TRANSLATOR_HPP
+
+#include "arinc_box_translator.h"
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace arinc_box
+{
+
+/** Start of header of a data packet sent to the converter box */
+inline constexpr uint8_t SOH_1 = 0x01u;
+
+/** Start of header of a data packet received from the converter box */
+inline constexpr uint8_t ACK = 0x06u;
+
+/** Carriage return */
+inline constexpr uint8_t CR = 0x0Du;
+
+/** Length in byte of a message received from the converter box */
+inline constexpr std::size_t DECODED_MSG_LENGTH = 7;
+
+/** Length in byte of a message sent to the converter box */
+inline constexpr std::size_t ENCODED_MSG_LENGTH = 10;
+
+/** Maximum size in byte of the buffer needed to decode one message */
+inline constexpr std::size_t MAX_BUFFER_LENGTH = 10;
+
+namespace detail
+{
+
+/**
+ * Builds the table giving, for each value of byte 6, the mask of the data bytes of the ARINC word
+ * that have to be converted back to ACK or CR.
+ * Bit 7 of byte 6 flags byte 5 (ARINC bits 24-31), bit 4 flags byte 2 (ARINC bits 0-7).
+ */
+constexpr std::array<uint32_t, 256> make_restore_mask_table()
+{
+    std::array<uint32_t, 256> table{};
+    for (std::size_t b6 = 0; b6 < table.size(); b6++)
+    {
+        uint32_t mask = 0;
+        for (uint32_t byte = 0; byte < 4; byte++)
+        {
+            if ((b6 >> (4 + byte)) & 1u)
+            {
+                mask |= 0xFFu << (8 * byte);
+            }
+        }
+        table[b6] = mask;
+    }
+    return table;
+}
+
+/**
+ * Builds the table giving the original value of an escaped data byte:
+ * 0x00 stands for ACK, any other value for CR.
+ */
+constexpr std::array<uint8_t, 256> make_restore_byte_table()
+{
+    std::array<uint8_t, 256> table{};
+    for (std::size_t b = 0; b < table.size(); b++)
+    {
+        table[b] = (b == 0x00u) ? ACK : CR;
+    }
+    return table;
+}
+
+inline constexpr std::array<uint32_t, 256> RESTORE_MASK = make_restore_mask_table();
+inline constexpr std::array<uint8_t, 256> RESTORE_BYTE = make_restore_byte_table();
+
+} // namespace detail
+
+/**
+ * Decodes the 32 bits word contained in a message received from the converter box.
+ *
+ * @param[in]   msg     Message received, from the ACK to the CR.
+ * @return The 32 bits ARINC word, with the bytes escaped by byte 6 converted back to ACK or CR.
+ */
+constexpr uint32_t decode_data(std::span<const uint8_t, DECODED_MSG_LENGTH> msg)
+{
+    const uint32_t raw = uint32_t{msg[1]} | (uint32_t{msg[2]} << 8) | (uint32_t{msg[3]} << 16) |
+                         (uint32_t{msg[4]} << 24);
+    const uint32_t restored = uint32_t{detail::RESTORE_BYTE[msg[1]]} |
+                              (uint32_t{detail::RESTORE_BYTE[msg[2]]} << 8) |
+                              (uint32_t{detail::RESTORE_BYTE[msg[3]]} << 16) |
+                              (uint32_t{detail::RESTORE_BYTE[msg[4]]} << 24);
+    const uint32_t mask = detail::RESTORE_MASK[msg[5]];
+
+    return (raw & ~mask) | (restored & mask);
+}
+
+/**
+ * Test if a message received from the converter box is an empty message.
+ *
+ * @param[in]   msg     Message received, from the ACK to the CR.
+ * @return true if the message received is an empty message.
+ */
+constexpr bool is_msg_empty(std::span<const uint8_t, DECODED_MSG_LENGTH> msg)
+{
+    return (msg[0] == ACK) && (msg[1] == 0x00u) && (msg[2] == 0x00u) && (msg[3] == 0x00u) &&
+           (msg[4] == 0x80u) && (msg[5] == 0x00u) && (msg[6] == CR);
+}
+
+/**
+ * Decodes an entire message received from the converter box.
+ *
+ * @param[in]   raw_msg     Message received, from the ACK to the CR.
+ * @return ARINC_ERROR if the message does not have the expected length, ARINC_EMPTY for an empty
+ * message, ARINC_RETURNED_DATA and the decoded word otherwise.
+ */
+constexpr arinc_box_msg_t decode_msg(std::span<const uint8_t> raw_msg)
+{
+    if (raw_msg.size() != DECODED_MSG_LENGTH)
+    {
+        return {ARINC_ERROR, 0};
+    }
+
+    const auto msg = raw_msg.first<DECODED_MSG_LENGTH>();
+    if (is_msg_empty(msg))
+    {
+        return {ARINC_EMPTY, 0};
+    }
+    return {ARINC_RETURNED_DATA, decode_data(msg)};
+}
+
+/**
+ * Encodes a 32 bits word to be transmitted to the converter box.
+ *
+ * @param[in]   arinc_data      32 bits arinc word to be encoded.
+ * @param[out]  encoded_char    Buffer that will be filled with the encoded message.
+ */
+constexpr void encode(uint32_t arinc_data, std::span<uint8_t, ENCODED_MSG_LENGTH> encoded_char)
+{
+    encoded_char[0] = SOH_1;
+    for (std::size_t i = 0; i < 8; i++)
+    {
+        encoded_char[1 + i] = static_cast<uint8_t>('A' + ((arinc_data >> (4 * i)) & 0xFu));
+    }
+    encoded_char[9] = CR;
+}
+
+/**
+ * Encodes a 32 bits word to be transmitted to the converter box.
+ *
+ * @param[in]   arinc_data      32 bits arinc word to be encoded.
+ * @return The encoded message.
+ */
+constexpr std::array<uint8_t, ENCODED_MSG_LENGTH> encode(uint32_t arinc_data)
+{
+    std::array<uint8_t, ENCODED_MSG_LENGTH> encoded_char{};
+    encode(arinc_data, encoded_char);
+    return encoded_char;
+}
+
+/**
+ * Receiver of the messages decoded by a decoder.
+ *
+ * on_data() is called with every ARINC word decoded, on_empty() for every empty message (time-out)
+ * and on_error() whenever arinc_box_decode() would have returned ARINC_ERROR.
+ * callback_sink, ring_sink and table_sink are provided, any other type with these members can be
+ * used as well.
+ */
+template <typename T>
+concept decoder_sink = requires(T &sink, uint32_t data_value) {
+    sink.on_data(data_value);
+    sink.on_empty();
+    sink.on_error();
+};
+
+/**
+ * Stateful decoder of the byte stream received from the converter box.
+ *
+ * Behaves exactly like arinc_box_decode(), except that the state is held by the object instead of
+ * static variables and the decoded messages are pushed to the sink instead of being returned.
+ * Pending bytes are not reported.
+ *
+ * @tparam Sink     Type fulfilling decoder_sink. May be a reference type to use an external sink.
+ */
+template <typename Sink>
+    requires decoder_sink<std::remove_reference_t<Sink>>
+class decoder
+{
+public:
+    constexpr explicit decoder(Sink sink) : sink_(std::forward<Sink>(sink)) {}
+
+    /**
+     * Decodes a byte received from the converter box.
+     *
+     * @param[in]   raw_data    Raw 8 bits data received.
+     */
+    constexpr void push(uint8_t raw_data)
+    {
+        if (raw_data == ACK)
+        {
+            // An ACK marks the beginning of a message
+            buffer_[0] = raw_data;
+            pos_ = 1;
+        }
+        else if ((pos_ > 0) && (pos_ < MAX_BUFFER_LENGTH))
+        {
+            // Store the byte received
+            buffer_[pos_] = raw_data;
+
+            if (raw_data == CR)
+            {
+                // A carriage return marks the end of a message, decode
+                dispatch(std::span<const uint8_t>(buffer_.data(), pos_ + 1u));
+                pos_ = 0;
+            }
+            else
+            {
+                // Current message is not totally received
+                pos_++;
+            }
+        }
+        else
+        {
+            sink_.on_error();
+        }
+    }
+
+    /**
+     * Decodes multiple bytes received from the converter box.
+     *
+     * @param[in]   raw_data    Raw data received.
+     */
+    constexpr void push(std::span<const uint8_t> raw_data)
+    {
+        for (const uint8_t byte : raw_data)
+        {
+            push(byte);
+        }
+    }
+
+    /** @return The sink receiving the decoded messages. */
+    constexpr std::remove_reference_t<Sink> &sink() { return sink_; }
+
+private:
+    constexpr void dispatch(std::span<const uint8_t> raw_msg)
+    {
+        if (raw_msg.size() != DECODED_MSG_LENGTH)
+        {
+            sink_.on_error();
+            return;
+        }
+
+        const auto msg = raw_msg.first<DECODED_MSG_LENGTH>();
+        if (is_msg_empty(msg))
+        {
+            sink_.on_empty();
+        }
+        else
+        {
+            sink_.on_data(decode_data(msg));
+        }
+    }
+
+    std::array<uint8_t, MAX_BUFFER_LENGTH> buffer_{};
+    std::size_t pos_ = 0;
+    Sink sink_;
+};
+
+/**
+ * Sink forwarding every decoded message, as an arinc_box_msg_t, to a callable.
+ *
+ * @tparam Callback     Callable accepting an arinc_box_msg_t.
+ */
+template <typename Callback>
+struct callback_sink
+{
+    Callback callback;
+
+    constexpr void on_data(uint32_t data_value)
+    {
+        callback(arinc_box_msg_t{ARINC_RETURNED_DATA, data_value});
+    }
+
+    constexpr void on_empty()
+    {
+        callback(arinc_box_msg_t{ARINC_EMPTY, 0});
+    }
+
+    constexpr void on_error()
+    {
+        callback(arinc_box_msg_t{ARINC_ERROR, 0});
+    }
+};
+
+template <typename Callback>
+callback_sink(Callback) -> callback_sink<Callback>;
+
+/**
+ * Sink storing the decoded words in a fixed size ring buffer, to be read with pop().
+ * Words decoded while the ring is full are dropped and counted as overruns.
+ *
+ * @tparam Capacity     Maximum number of words stored.
+ */
+template <std::size_t Capacity>
+class ring_sink
+{
+public:
+    static_assert(Capacity > 0, "A ring sink needs a capacity of at least one word");
+
+    constexpr void on_data(uint32_t data_value)
+    {
+        if (count_ == Capacity)
+        {
+            overruns_++;
+            return;
+        }
+        words_[(head_ + count_) % Capacity] = data_value;
+        count_++;
+    }
+
+    constexpr void on_empty() {}
+
+    constexpr void on_error() { errors_++; }
+
+    /**
+     * Removes the oldest word from the ring.
+     *
+     * @param[out]  data_value  Oldest word, only set if the ring is not empty.
+     * @return false if the ring is empty.
+     */
+    constexpr bool pop(uint32_t &data_value)
+    {
+        if (count_ == 0)
+        {
+            return false;
+        }
+        data_value = words_[head_];
+        head_ = (head_ + 1) % Capacity;
+        count_--;
+        return true;
+    }
+
+    /** @return Number of words stored. */
+    constexpr std::size_t size() const { return count_; }
+
+    /** @return Number of words dropped because the ring was full. */
+    constexpr std::size_t overruns() const { return overruns_; }
+
+    /** @return Number of decoding errors. */
+    constexpr std::size_t errors() const { return errors_; }
+
+private:
+    std::array<uint32_t, Capacity> words_{};
+    std::size_t head_ = 0;
+    std::size_t count_ = 0;
+    std::size_t overruns_ = 0;
+    std::size_t errors_ = 0;
+};
+
+/**
+ * Sink keeping the last word received for every ARINC label, the label being the 8 least
+ * significant bits of the word.
+ */
+class table_sink
+{
+public:
+    /** Number of ARINC labels */
+    static constexpr std::size_t LABEL_COUNT = 256;
+
+    constexpr void on_data(uint32_t data_value)
+    {
+        const std::size_t label = data_value & 0xFFu;
+        words_[label] = data_value;
+        updates_[label]++;
+    }
+
+    constexpr void on_empty() {}
+
+    constexpr void on_error() { errors_++; }
+
+    /** @return Last word received with the label, 0 if none was received yet. */
+    constexpr uint32_t word(uint8_t label) const { return words_[label]; }
+
+    /** @return Number of words received with the label. */
+    constexpr uint32_t updates(uint8_t label) const { return updates_[label]; }
+
+    /** @return Number of decoding errors. */
+    constexpr std::size_t errors() const { return errors_; }
+
+private:
+    std::array<uint32_t, LABEL_COUNT> words_{};
+    std::array<uint32_t, LABEL_COUNT> updates_{};
+    std::size_t errors_ = 0;
+};
+
+template <typename Sink>
+decoder(Sink) -> decoder<Sink>;
+
+} // namespace arinc_box
+
+#endif
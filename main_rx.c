@@ -23,6 +23,7 @@
 #include "arinc_box_translator.h"
 #include "serial.h"
 #include <conio.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -31,6 +32,37 @@
 /** Default baudrate at which the serial port is read */
 #define DEFAULT_BAUDRATE 230400
 
+/** Size in byte of the buffer the serial port is read into */
+#define RX_BUFFER_LENGTH 512
+
+/** Length in byte of one frame sent by the ARINC-429-TO-USB converter box */
+#define FRAME_LENGTH 7
+
+/** Time window in ms during which the bytes received are coalesced in the power read mode */
+#define LOW_POWER_WINDOW_MS 20
+
+/** How the serial port is read */
+typedef enum
+{
+    RX_MODE_LATENCY,                /**< Busy-poll non blocking reads on a pinned CPU */
+    RX_MODE_BALANCED,               /**< Blocking reads of at most one frame */
+    RX_MODE_POWER                   /**< Blocking reads, then wait LOW_POWER_WINDOW_MS and drain the bytes received */
+} rx_mode_t;
+
+/** Statistics about the reads done on the serial port */
+typedef struct
+{
+    LARGE_INTEGER start;            /**< Performance counter when the reception started */
+    uint32_t reads;                 /**< Number of returns from serial_read() */
+    uint32_t reads_full;            /**< Number of reads that filled the buffer */
+    uint32_t reads_partial;         /**< Number of reads that returned data without filling the buffer */
+    uint32_t reads_empty;           /**< Number of reads that returned no data (time-out or empty poll) */
+    uint32_t sleeps;                /**< Number of coalescing sleeps (power read mode) */
+    uint32_t messages;              /**< Number of messages decoded */
+    double delay_sum_us;            /**< Sum of the delivery delays */
+    double delay_max_us;            /**< Maximum delivery delay */
+} rx_stats_t;
+
 static void print_header()
 {
     printf("\n");
@@ -46,12 +78,20 @@ static void print_help()
     printf("\n");
     printf("\n");
 
-    printf("Usage: arinc_box_rx.exe serial-port [baudrate]\n");
+    printf("Usage: arinc_box_rx.exe serial-port [baudrate] [read-mode] [cpu]\n");
     printf("Example: arinc_box_rx.exe COM5\n");
+    printf("Example: arinc_box_rx.exe COM5 230400 latency-rt 2\n");
     printf("\n");
     printf("Arguments: \n");
     printf("\tserial-port: Virtual serial port on which the converter box is connected.\n");
     printf("\tbaudrate:    Set the baudrate. By default, 230400 is used. \n");
+    printf("\tread-mode:   How the serial port is read. By default, balanced is used. \n");
+    printf("\t             latency:    busy-poll the serial port, pinned on one CPU (uses a full core)\n");
+    printf("\t             latency-rt: same as latency, with real-time priority\n");
+    printf("\t             balanced:   blocking reads of at most one frame (%d bytes),\n", FRAME_LENGTH);
+    printf("\t                         returning as soon as data arrives\n");
+    printf("\t             power:      blocking reads, then coalescing %d ms of data\n", LOW_POWER_WINDOW_MS);
+    printf("\tcpu:         CPU the latency modes are pinned on. By default, the highest CPU available is used. \n");
     printf("\n");
     printf("\n");
     printf("Other usage: arinc_box_rx.exe --help\n");
@@ -64,6 +104,142 @@ static void print_help()
     printf("\n");
 }
 
+/**
+ * Pin the current thread on one CPU and optionally give it real-time priority.
+ *
+ * @param[in]   cpu         Index of the CPU the thread shall run on.
+ * @param[in]   realtime    Raise the priority of the process and thread to real-time.
+ */
+static void set_low_latency_scheduling(uint32_t cpu, bool realtime)
+{
+    if (SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) == 0)
+    {
+        printf("Warning: couldn't pin the thread on CPU %u\n", cpu);
+    }
+
+    if (realtime)
+    {
+        // Without administrator rights, Windows silently falls back to HIGH_PRIORITY_CLASS
+        if ((SetPriorityClass(GetCurrentProcess(), REALTIME_PRIORITY_CLASS) == 0) ||
+            (SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) == 0))
+        {
+            printf("Warning: couldn't set real-time priority\n");
+        }
+    }
+}
+
+/**
+ * Get the highest CPU the process is allowed to run on.
+ * CPU 0 handles most of the interrupts on Windows, so it is the worst choice for a busy loop.
+ *
+ * @param[in]   cpu_mask    Affinity mask of the process.
+ * @return Index of the highest CPU set in the mask.
+ */
+static uint32_t highest_cpu(DWORD_PTR cpu_mask)
+{
+    uint32_t cpu = 0;
+    for (uint32_t i = 0; i < sizeof(DWORD_PTR) * 8; i++)
+    {
+        if ((cpu_mask >> i) & 1)
+        {
+            cpu = i;
+        }
+    }
+    return cpu;
+}
+
+/**
+ * Parse the CPU argument.
+ *
+ * @param[in]   arg         Argument passed by the user.
+ * @param[in]   cpu_mask    Affinity mask of the process.
+ * @param[out]  cpu         Index of the CPU, only set if the argument is valid.
+ * @return true if the argument is a CPU the process is allowed to run on.
+ */
+static bool parse_cpu(const char *arg, DWORD_PTR cpu_mask, uint32_t *cpu)
+{
+    char *end = NULL;
+    unsigned long value = strtoul(arg, &end, 10);
+
+    if ((end == arg) || (*end != '\0') || (value >= sizeof(DWORD_PTR) * 8) || (((cpu_mask >> value) & 1) == 0))
+    {
+        return false;
+    }
+    *cpu = (uint32_t)value;
+    return true;
+}
+
+/**
+ * Microseconds elapsed between two performance counter values.
+ */
+static double elapsed_us(LARGE_INTEGER from, LARGE_INTEGER to)
+{
+    static LARGE_INTEGER frequency = {0};
+    if (frequency.QuadPart == 0)
+    {
+        QueryPerformanceFrequency(&frequency);
+    }
+    return (double)(to.QuadPart - from.QuadPart) * 1e6 / (double)frequency.QuadPart;
+}
+
+/**
+ * Account for one return from serial_read().
+ *
+ * @param[in,out]   stats       Statistics gathered during the reception.
+ * @param[in]       received    Number of bytes returned by the read.
+ * @param[in]       size        Number of bytes requested.
+ */
+static void count_read(rx_stats_t *stats, uint32_t received, uint32_t size)
+{
+    stats->reads++;
+    if (received == 0)
+    {
+        stats->reads_empty++;
+    }
+    else if (received == size)
+    {
+        stats->reads_full++;
+    }
+    else
+    {
+        stats->reads_partial++;
+    }
+}
+
+/**
+ * Print the CPU usage, the wakeups and the delivery delay measured with the read mode.
+ *
+ * @param[in]   stats       Statistics gathered during the reception.
+ * @param[in]   mode        Read mode used.
+ * @param[in]   mode_name   Name of the read mode used.
+ */
+static void print_stats(const rx_stats_t *stats, rx_mode_t mode, const char *mode_name)
+{
+    LARGE_INTEGER now;
+    FILETIME creation, exit, kernel, user;
+    QueryPerformanceCounter(&now);
+    GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+
+    // FILETIME values are in units of 100 ns
+    double cpu_us = (double)((((uint64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime) +
+                             (((uint64_t)user.dwHighDateTime << 32) | user.dwLowDateTime)) / 10.0;
+    double wall_us = elapsed_us(stats->start, now);
+
+    printf("\nRead mode: %s\n", mode_name);
+    printf("CPU usage: %.1f %% of one core\n", (wall_us > 0) ? (100.0 * cpu_us / wall_us) : 0.0);
+    uint32_t wakeups = stats->reads + stats->sleeps;
+    printf("Wakeups: %u (%.1f per second): %u reads, %u coalescing sleeps\n",
+           wakeups, (wall_us > 0) ? (wakeups * 1e6 / wall_us) : 0.0, stats->reads, stats->sleeps);
+    printf("Reads: %u filled the buffer, %u returned before it was full, %u returned no data\n",
+           stats->reads_full, stats->reads_partial, stats->reads_empty);
+    if (stats->messages > 0)
+    {
+        printf("Delivery delay: mean %.1f us, max %.1f us over %u messages%s\n",
+               stats->delay_sum_us / stats->messages, stats->delay_max_us, stats->messages,
+               (mode == RX_MODE_LATENCY) ? " (upper bound, from the previous poll)" : "");
+    }
+}
+
 int main(int argc, char **argv)
 {
     int32_t return_code = EXIT_FAILURE;
@@ -71,7 +247,14 @@ int main(int argc, char **argv)
         {
             .baudrate = DEFAULT_BAUDRATE,
             .com_port = "\\\\.\\",
+            .read_policy = SERIAL_READ_BLOCKING,
             .windows_handle = NULL};
+    rx_mode_t mode = RX_MODE_BALANCED;
+    const char *mode_name = "balanced";
+    bool realtime = false;
+    DWORD_PTR process_mask = 1;
+    DWORD_PTR system_mask = 1;
+    uint32_t cpu = 0;
 
     
     print_header();
@@ -80,6 +263,55 @@ int main(int argc, char **argv)
         arinc_serial.baudrate = strtol(argv[2], NULL, 10);
     }
 
+    if (argc > 3)
+    {
+        mode_name = argv[3];
+        if (strcmp(mode_name, "latency") == 0)
+        {
+            mode = RX_MODE_LATENCY;
+            arinc_serial.read_policy = SERIAL_READ_NON_BLOCKING;
+        }
+        else if (strcmp(mode_name, "latency-rt") == 0)
+        {
+            mode = RX_MODE_LATENCY;
+            arinc_serial.read_policy = SERIAL_READ_NON_BLOCKING;
+            realtime = true;
+        }
+        else if (strcmp(mode_name, "power") == 0)
+        {
+            mode = RX_MODE_POWER;
+        }
+        else if (strcmp(mode_name, "balanced") != 0)
+        {
+            printf("Unknown read mode '%s', using balanced\n", mode_name);
+            mode_name = "balanced";
+        }
+    }
+
+    if (mode == RX_MODE_LATENCY)
+    {
+        if (GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask) == 0)
+        {
+            process_mask = 1;
+        }
+        cpu = highest_cpu(process_mask);
+
+        if ((argc > 4) && !parse_cpu(argv[4], process_mask, &cpu))
+        {
+            printf("Invalid CPU '%s', using CPU %u\n", argv[4], cpu);
+        }
+
+        if (realtime && (process_mask == ((DWORD_PTR)1 << cpu)))
+        {
+            printf("Only one CPU available, real-time priority disabled\n");
+            realtime = false;
+        }
+    }
+    else if (argc > 4)
+    {
+        printf("CPU '%s' ignored, the %s read mode doesn't pin the thread on a CPU\n", argv[4], mode_name);
+    }
+
     if ((argc > 1) && ((strcmp(argv[1], "--help") == 0) || (strcmp(argv[1], "-help") == 0)))
     {
         print_help();
@@ -90,26 +322,96 @@ int main(int argc, char **argv)
 
         if (serial_open(&arinc_serial) == EXIT_SUCCESS)
         {
-            printf("Starting on %s @ B%d\n", arinc_serial.com_port, arinc_serial.baudrate);
+            printf("Starting on %s @ B%d, read mode %s\n", arinc_serial.com_port, arinc_serial.baudrate, mode_name);
             printf("Hit any key to exit\n\n");
 
-            arinc_box_msg_t msg_in;
+            uint32_t read_size = RX_BUFFER_LENGTH;
+            if (mode == RX_MODE_LATENCY)
+            {
+                printf("Pinned on CPU %u\n\n", cpu);
+                set_low_latency_scheduling(cpu, realtime);
+            }
+            else if (mode == RX_MODE_BALANCED)
+            {
+                read_size = FRAME_LENGTH;
+            }
+
+            rx_stats_t stats = {0};
+            QueryPerformanceCounter(&stats.start);
+
+            char rx_buffer[RX_BUFFER_LENGTH];
+            arinc_box_msg_t decoded_msgs[RX_BUFFER_LENGTH];
+            LARGE_INTEGER last_return = stats.start;
             while(!kbhit())
             {
-                char data = 0;
-                if(serial_get_byte(&arinc_serial, &data) == EXIT_SUCCESS)
+                uint32_t received = 0;
+                LARGE_INTEGER previous_return = last_return;
+                int32_t status = serial_read(&arinc_serial, rx_buffer, read_size, &received);
+                QueryPerformanceCounter(&last_return);
+                count_read(&stats, received, read_size);
+
+                if((status == EXIT_SUCCESS) && (received > 0))
                 {
-                    msg_in = arinc_box_decode(data);
-                    if(msg_in.msg_type == ARINC_RETURNED_DATA)
+                    // A blocking read returns as soon as a byte arrives. A poll only tells that the data
+                    // arrived at some point since the previous poll.
+                    LARGE_INTEGER available = (mode == RX_MODE_LATENCY) ? previous_return : last_return;
+
+                    if ((mode == RX_MODE_POWER) && (received < RX_BUFFER_LENGTH))
+                    {
+                        // Let the rest of the window accumulate in the driver, then drain it
+                        uint32_t queued = 0;
+                        Sleep(LOW_POWER_WINDOW_MS);
+                        stats.sleeps++;
+                        if ((serial_get_queued(&arinc_serial, &queued) == EXIT_SUCCESS) && (queued > 0))
+                        {
+                            uint32_t space = RX_BUFFER_LENGTH - received;
+                            uint32_t drain_size = (queued < space) ? queued : space;
+                            uint32_t drained = 0;
+                            serial_read(&arinc_serial, rx_buffer + received, drain_size, &drained);
+                            QueryPerformanceCounter(&last_return);
+                            count_read(&stats, drained, drain_size);
+                            received += drained;
+                        }
+                    }
+
+                    // Decode the whole batch first, so that printing doesn't count in the delay
+                    uint32_t nb_decoded = 0;
+                    for (uint32_t i = 0; i < received; i++)
                     {
-                        printf("0x%08X\n", msg_in.data_value);
+                        arinc_box_msg_t msg_in = arinc_box_decode(rx_buffer[i]);
+                        if(msg_in.msg_type == ARINC_RETURNED_DATA)
+                        {
+                            LARGE_INTEGER decoded;
+                            QueryPerformanceCounter(&decoded);
+                            double delay_us = elapsed_us(available, decoded);
+                            stats.messages++;
+                            stats.delay_sum_us += delay_us;
+                            if (delay_us > stats.delay_max_us)
+                            {
+                                stats.delay_max_us = delay_us;
+                            }
+                            decoded_msgs[nb_decoded++] = msg_in;
+                        }
+                        else if(msg_in.msg_type == ARINC_ERROR)
+                        {
+                            decoded_msgs[nb_decoded++] = msg_in;
+                        }
                     }
-                    else if(msg_in.msg_type == ARINC_ERROR)
+
+                    for (uint32_t i = 0; i < nb_decoded; i++)
                     {
-                        printf("Error decoding the message!\n");
+                        if(decoded_msgs[i].msg_type == ARINC_RETURNED_DATA)
+                        {
+                            printf("0x%08X\n", decoded_msgs[i].data_value);
+                        }
+                        else
+                        {
+                            printf("Error decoding the message!\n");
+                        }
                     }
                 }
             }
+            print_stats(&stats, mode, mode_name);
             serial_close(&arinc_serial);
         }
         else
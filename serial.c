@@ -25,10 +25,31 @@ int32_t serial_open(serial_port_t *serial)
         return EXIT_FAILURE;
     }
 
-    // No (minimal) blocking!
-    timeouts.ReadIntervalTimeout = 1;
-    timeouts.ReadTotalTimeoutMultiplier = 0;
-    timeouts.ReadTotalTimeoutConstant = 1;
+    switch (serial->read_policy)
+    {
+    case SERIAL_READ_NON_BLOCKING:
+        // No blocking at all, return immediately with the bytes already received
+        timeouts.ReadIntervalTimeout = MAXDWORD;
+        timeouts.ReadTotalTimeoutMultiplier = 0;
+        timeouts.ReadTotalTimeoutConstant = 0;
+        break;
+
+    case SERIAL_READ_BLOCKING:
+        // Return immediately with the bytes already received, or as soon as the next byte arrives.
+        // Only time out when no byte at all arrived.
+        timeouts.ReadIntervalTimeout = MAXDWORD;
+        timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
+        timeouts.ReadTotalTimeoutConstant = SERIAL_IDLE_TIMEOUT_MS;
+        break;
+
+    case SERIAL_READ_DEFAULT:
+    default:
+        // No (minimal) blocking!
+        timeouts.ReadIntervalTimeout = 1;
+        timeouts.ReadTotalTimeoutMultiplier = 0;
+        timeouts.ReadTotalTimeoutConstant = 1;
+        break;
+    }
     timeouts.WriteTotalTimeoutMultiplier = 0;
     timeouts.WriteTotalTimeoutConstant = 0;
     if (SetCommTimeouts(serial->windows_handle, &timeouts) == 0)
@@ -98,6 +119,37 @@ int32_t serial_get_buffer(serial_port_t *serial, char *data, uint32_t size)
     }
 }
 
+int32_t serial_read(serial_port_t *serial, char *data, uint32_t size, uint32_t *received)
+{
+    long unsigned int cnt = 0;
+    bool success = ReadFile(serial->windows_handle, data, size, &cnt, NULL);
+    *received = success ? cnt : 0;
+    if (success)
+    {
+        return EXIT_SUCCESS;
+    }
+    else
+    {
+        return EXIT_FAILURE;
+    }
+}
+
+int32_t serial_get_queued(serial_port_t *serial, uint32_t *queued)
+{
+    DWORD errors = 0;
+    COMSTAT status;
+    if (ClearCommError(serial->windows_handle, &errors, &status) != 0)
+    {
+        *queued = status.cbInQue;
+        return EXIT_SUCCESS;
+    }
+    else
+    {
+        *queued = 0;
+        return EXIT_FAILURE;
+    }
+}
+
 int32_t serial_send_byte(serial_port_t *serial, char data)
 {
     long unsigned int cnt = 0;
@@ -19,11 +19,23 @@
 #include <stdint.h>
 #include <windows.h>
 
+/** Policy used to wait for the bytes received on a serial port */
+typedef enum
+{
+    SERIAL_READ_DEFAULT = 0,       /**< Reads wait up to about 1 ms for data */
+    SERIAL_READ_NON_BLOCKING = 1,  /**< Reads return immediately with the bytes already received */
+    SERIAL_READ_BLOCKING = 2       /**< Reads return as soon as bytes are received, or after SERIAL_IDLE_TIMEOUT_MS */
+} serial_read_policy_t;
+
+/** Maximum time in ms a read blocks in the SERIAL_READ_BLOCKING policy when no data is received */
+#define SERIAL_IDLE_TIMEOUT_MS 100
+
 /** Structure of a serial port */
 typedef struct
 {
     char com_port[32];
     uint32_t baudrate;
+    serial_read_policy_t read_policy;
     HANDLE windows_handle;
 } serial_port_t;
 
@@ -50,6 +62,7 @@ int32_t serial_close(serial_port_t *serial);
 /**
  * Read a byte received through a serial port.
  * @note A call to the function serial_open() shall have been done before calling this function
+ * @note How long the function waits for the byte depends on the read policy of the serial port.
  *
  * @param[in,out]   serial      Pointer to the serial port returned by the function serial_open()
  * @param[out]      data        Pointer to the variable that will contain the read character.
@@ -60,6 +73,7 @@ int32_t serial_get_byte(serial_port_t *serial, char *data);
 /**
  * Read multiple bytes received through a serial port.
  * @note A call to the function serial_open() shall have been done before calling this function
+ * @note How long the function waits for the bytes depends on the read policy of the serial port.
  *
  * @param[in,out]   serial      Pointer to the serial port returned by the function serial_open()
  * @param[out]      data        Pointer to the variable that will contain the read characters.
@@ -68,6 +82,29 @@ int32_t serial_get_byte(serial_port_t *serial, char *data);
  */
 int32_t serial_get_buffer(serial_port_t *serial, char *data, uint32_t size);
 
+/**
+ * Read the bytes received through a serial port, waiting for them according to the read policy
+ * of the serial port.
+ * @note A call to the function serial_open() shall have been done before calling this function
+ *
+ * @param[in,out]   serial      Pointer to the serial port returned by the function serial_open()
+ * @param[out]      data        Pointer to the variable that will contain the read characters.
+ * @param[in]       size        Maximum number of bytes to read
+ * @param[out]      received    Number of bytes actually read
+ * @return EXIT_FAILURE if an error occurred during the read operation, EXIT_SUCCESS otherwise.
+ */
+int32_t serial_read(serial_port_t *serial, char *data, uint32_t size, uint32_t *received);
+
+/**
+ * Get the number of bytes received through a serial port that have not been read yet.
+ * @note A call to the function serial_open() shall have been done before calling this function
+ *
+ * @param[in,out]   serial      Pointer to the serial port returned by the function serial_open()
+ * @param[out]      queued      Number of bytes waiting to be read
+ * @return EXIT_FAILURE if the state of the serial port couldn't be read, EXIT_SUCCESS otherwise.
+ */
+int32_t serial_get_queued(serial_port_t *serial, uint32_t *queued);
+
 /**
  * Write a byte through a serial port.
  * @note A call to the function serial_open() shall have been done before calling this function
@@ -0,0 +1,270 @@
+/*
+ * 2023 (c) Simtec AG
+ * All rights reserved
+ *
+ * Differential test and benchmark of the header-only C++ translator (arinc_box_translator.hpp)
+ * against the C implementation (arinc_box_translator.c).
+ *
+ * The C++ decoder shall report exactly the same messages as arinc_box_decode() for any byte
+ * stream, and arinc_box::encode() shall produce exactly the same bytes as arinc_box_encode().
+ * The benchmark decodes the same stream of valid frames with both implementations and prints
+ * the time taken by each of them.
+ *
+ * Build and run with: make test_cpp
+ *
+ * Example code only. Use at own risk.
+ */
+
+#include "arinc_box_translator.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+/** Number of random bytes fed to both decoders */
+#define RANDOM_STREAM_LENGTH 5000000
+
+/** Number of valid frames decoded by the benchmark */
+#define BENCHMARK_FRAMES 2000000
+
+/** Number of times the benchmark is repeated, the fastest run is kept */
+#define BENCHMARK_RUNS 5
+
+// Compile-time checks of the constexpr paths
+
+/** Byte 6 = 0xF0 escapes all four data bytes: 0x00 becomes ACK, any other value CR */
+static_assert(arinc_box::decode_data(
+                  std::array<uint8_t, 7>{0x06, 0x00, 0x01, 0x00, 0xFF, 0xF0, 0x0D}) == 0x0D060D06u);
+
+/** Bits 0 to 3 of byte 6 are ignored */
+static_assert(arinc_box::decode_data(
+                  std::array<uint8_t, 7>{0x06, 0x12, 0x34, 0x56, 0x78, 0x0F, 0x0D}) == 0x78563412u);
+
+/** Only the data bytes flagged in byte 6 are restored */
+static_assert(arinc_box::decode_data(
+                  std::array<uint8_t, 7>{0x06, 0x00, 0xAA, 0x00, 0x12, 0xA0, 0x0D}) == 0x0D000D00u);
+
+/** The empty message is reported as such, a message of the wrong length as an error */
+constexpr std::array<uint8_t, 7> EMPTY_MSG = {0x06, 0x00, 0x00, 0x00, 0x80, 0x00, 0x0D};
+static_assert(arinc_box::decode_msg(EMPTY_MSG).msg_type == ARINC_EMPTY);
+
+static_assert(arinc_box::decode_msg(std::array<uint8_t, 6>{0x06, 0x00, 0x00, 0x80, 0x00, 0x0D})
+                  .msg_type == ARINC_ERROR);
+
+/** Every nibble is sent as 'A' + nibble, least significant first */
+static_assert(arinc_box::encode(0x12345678u) ==
+              std::array<uint8_t, 10>{0x01, 'I', 'H', 'G', 'F', 'E', 'D', 'C', 'B', 0x0D});
+
+static_assert(arinc_box::encode(0xFFFFFFFFu) ==
+              std::array<uint8_t, 10>{0x01, 'P', 'P', 'P', 'P', 'P', 'P', 'P', 'P', 0x0D});
+
+/** A decoder pushing to a table sink can run at compile time */
+constexpr uint32_t decode_at_compile_time()
+{
+    arinc_box::decoder<arinc_box::table_sink> decoder{arinc_box::table_sink{}};
+    decoder.push(std::array<uint8_t, 8>{0x55, 0x06, 0x42, 0x34, 0x56, 0x00, 0x80, 0x0D});
+    return decoder.sink().word(0x42) + static_cast<uint32_t>(decoder.sink().errors());
+}
+static_assert(decode_at_compile_time() == 0x06563442u + 1u);
+
+/** Sink recording every message reported by the C++ decoder */
+struct last_msg_sink
+{
+    arinc_box_msg_t msg;
+    uint32_t count;
+
+    void on_data(uint32_t data_value)
+    {
+        msg = arinc_box_msg_t{ARINC_RETURNED_DATA, data_value};
+        count++;
+    }
+
+    void on_empty()
+    {
+        msg = arinc_box_msg_t{ARINC_EMPTY, 0};
+        count++;
+    }
+
+    void on_error()
+    {
+        msg = arinc_box_msg_t{ARINC_ERROR, 0};
+        count++;
+    }
+};
+
+/** Sink summing up the decoded words, so that the benchmark cannot be optimized away */
+struct checksum_sink
+{
+    uint64_t sum;
+
+    void on_data(uint32_t data_value) { sum += data_value; }
+    void on_empty() { sum += 1; }
+    void on_error() { sum += 3; }
+};
+
+/**
+ * Feed the same stream to both decoders and compare every message reported.
+ *
+ * @return Number of mismatches.
+ */
+static uint32_t compare_decoders(const std::vector<uint8_t> &stream, uint32_t *nb_msgs)
+{
+    uint32_t mismatches = 0;
+    last_msg_sink sink = {};
+    arinc_box::decoder<last_msg_sink &> decoder(sink);
+
+    for (const uint8_t byte : stream)
+    {
+        const arinc_box_msg_t expected = arinc_box_decode(static_cast<char>(byte));
+        const uint32_t count_before = sink.count;
+        decoder.push(byte);
+
+        if (expected.msg_type == ARINC_PENDING)
+        {
+            mismatches += (sink.count != count_before) ? 1u : 0u;
+            continue;
+        }
+
+        (*nb_msgs)++;
+        if ((sink.count != count_before + 1) || (sink.msg.msg_type != expected.msg_type) ||
+            ((expected.msg_type != ARINC_ERROR) && (sink.msg.data_value != expected.data_value)))
+        {
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+/**
+ * Compare both encoders on a sweep of the 32 bits words.
+ *
+ * @return Number of mismatches.
+ */
+static uint32_t compare_encoders()
+{
+    uint32_t mismatches = 0;
+    for (uint64_t word = 0; word <= 0xFFFFFFFFu; word += 65521)
+    {
+        uint8_t expected[10];
+        arinc_box_encode(static_cast<uint32_t>(word), expected);
+        const std::array<uint8_t, 10> encoded = arinc_box::encode(static_cast<uint32_t>(word));
+        for (std::size_t i = 0; i < encoded.size(); i++)
+        {
+            mismatches += (encoded[i] != expected[i]) ? 1u : 0u;
+        }
+    }
+    return mismatches;
+}
+
+/** Random stream biased towards ACK, CR and 0x00, so that many complete messages are built */
+static std::vector<uint8_t> make_random_stream(std::mt19937 &rng)
+{
+    std::vector<uint8_t> stream(RANDOM_STREAM_LENGTH);
+    std::uniform_int_distribution<int> pick(0, 9);
+    for (uint8_t &byte : stream)
+    {
+        const int kind = pick(rng);
+        byte = (kind == 0)   ? 0x06
+               : (kind == 1) ? 0x0D
+               : (kind == 2) ? 0x00
+                             : static_cast<uint8_t>(rng());
+    }
+    return stream;
+}
+
+/** Stream of valid frames, with random words and escape flags */
+static std::vector<uint8_t> make_frame_stream(std::mt19937 &rng)
+{
+    std::vector<uint8_t> stream;
+    stream.reserve(BENCHMARK_FRAMES * 7);
+    for (uint32_t i = 0; i < BENCHMARK_FRAMES; i++)
+    {
+        uint8_t frame[7] = {0x06, 0, 0, 0, 0, static_cast<uint8_t>(rng() & 0xF0u), 0x0D};
+        for (std::size_t j = 1; j < 5; j++)
+        {
+            frame[j] = static_cast<uint8_t>(rng());
+            if ((frame[j] == 0x06) || (frame[j] == 0x0D))
+            {
+                frame[j] = 0x01;
+            }
+        }
+        stream.insert(stream.end(), frame, frame + 7);
+    }
+    return stream;
+}
+
+static double run_c_decoder(const std::vector<uint8_t> &stream, uint64_t *checksum)
+{
+    const auto start = std::chrono::steady_clock::now();
+    uint64_t sum = 0;
+    for (const uint8_t byte : stream)
+    {
+        const arinc_box_msg_t msg = arinc_box_decode(static_cast<char>(byte));
+        if (msg.msg_type == ARINC_RETURNED_DATA)
+        {
+            sum += msg.data_value;
+        }
+        else if (msg.msg_type == ARINC_EMPTY)
+        {
+            sum += 1;
+        }
+        else if (msg.msg_type == ARINC_ERROR)
+        {
+            sum += 3;
+        }
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    *checksum = sum;
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+static double run_cpp_decoder(const std::vector<uint8_t> &stream, uint64_t *checksum)
+{
+    const auto start = std::chrono::steady_clock::now();
+    arinc_box::decoder<checksum_sink> decoder(checksum_sink{});
+    decoder.push(stream);
+    const auto stop = std::chrono::steady_clock::now();
+    *checksum = decoder.sink().sum;
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+int main()
+{
+    std::mt19937 rng(429);
+    uint32_t nb_msgs = 0;
+
+    // Both streams start with an ACK, which resets the state of both decoders
+    const std::vector<uint8_t> random_stream = make_random_stream(rng);
+    const std::vector<uint8_t> frame_stream = make_frame_stream(rng);
+    uint32_t decode_mismatches = compare_decoders(random_stream, &nb_msgs);
+    decode_mismatches += compare_decoders(frame_stream, &nb_msgs);
+    const uint32_t encode_mismatches = compare_encoders();
+
+    printf("Decoder: %u messages compared, %u mismatches\n", nb_msgs, decode_mismatches);
+    printf("Encoder: %u mismatching bytes\n", encode_mismatches);
+
+    double best_c_ms = 0;
+    double best_cpp_ms = 0;
+    uint64_t checksum_c = 0;
+    uint64_t checksum_cpp = 0;
+    for (uint32_t run = 0; run < BENCHMARK_RUNS; run++)
+    {
+        const double c_ms = run_c_decoder(frame_stream, &checksum_c);
+        const double cpp_ms = run_cpp_decoder(frame_stream, &checksum_cpp);
+        best_c_ms = ((run == 0) || (c_ms < best_c_ms)) ? c_ms : best_c_ms;
+        best_cpp_ms = ((run == 0) || (cpp_ms < best_cpp_ms)) ? cpp_ms : best_cpp_ms;
+    }
+
+    printf("Benchmark, %u frames, best of %u runs:\n", BENCHMARK_FRAMES, BENCHMARK_RUNS);
+    printf("\tC   arinc_box_decode():   %8.2f ms\n", best_c_ms);
+    printf("\tC++ arinc_box::decoder:   %8.2f ms\n", best_cpp_ms);
+
+    if ((decode_mismatches != 0) || (encode_mismatches != 0) || (checksum_c != checksum_cpp))
+    {
+        printf("FAILED\n");
+        return EXIT_FAILURE;
+    }
+    printf("PASSED\n");
+    return EXIT_SUCCESS;
+}